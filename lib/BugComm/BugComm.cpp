@@ -13,6 +13,7 @@ void BugComm::send_command(int8_t x, int8_t y, bool button) {
   if(0 > delta) delta = 1.0 + delta;
   else if(0 < delta) delta = -(1.0 - delta);
   if(last_x != x || last_y != y || last_b != button) {
+    command.op = BUGCOMM_OP_DRIVE;
     last_x = x;
     last_y = y;
     last_b = button;
@@ -35,6 +36,29 @@ void BugComm::send_command(int8_t x, int8_t y, bool button) {
 }
 
 
+// Upload a script and start it; the receiver plays it back with local timing.
+// If the receiver rejects the script, get_response_status() becomes NOWCOMM_RESP_ERROR.
+//
+void BugComm::run_script(const BugScript* script) {
+  memcpy(&command.script, script, sizeof(BugScript));
+  send_op(BUGCOMM_OP_RUN_SCRIPT);
+}
+
+
+void BugComm::stop_script() {
+  send_op(BUGCOMM_OP_STOP_SCRIPT);
+}
+
+
+// Send a non-drive command. The last joystick reading is left alone, so send_command()
+// only sends a drive command (which preempts a running script) when the joystick moves.
+//
+void BugComm::send_op(BugComm_Op op) {
+  command.op = op;
+  NowComm<BugCommand>::send_command(&command);
+}
+
+
 uint32_t BugComm::get_light_color(uint8_t pos) {
   if(pos > 2) return 0;
   return (pos == 0) ? command.color_left : command.color_right;
@@ -55,3 +79,13 @@ uint8_t  BugComm::get_motor_speed(uint8_t pos) {
 uint8_t  BugComm::get_button() {
   return command.button;
 }
+
+
+BugComm_Op BugComm::get_op() {
+  return command.op;
+}
+
+
+BugScript* BugComm::get_script() {
+  return &command.script;
+}
@@ -1,12 +1,32 @@
 #pragma once
 #include <NowComm.h>
+#include <BugScript.h>
 
 // Just a test of the NowComm Template Class
 
+
+// What the receiver should do with a BugCommand.
+// Only BUGCOMM_OP_DRIVE uses the speed, color and button fields; only BUGCOMM_OP_RUN_SCRIPT uses script.
+// BUGCOMM_OP_RUN_SCRIPT loads and starts its script in one step, so a single packet can't be split
+// by another command arriving in between. If the script is rejected the receiver answers with
+// NOWCOMM_RESP_ERROR, following the NOWCOMM_RESP_NOERR sent on receipt.
+// A drive command received while a script is running preempts the script.
+//
+enum BugComm_Op {
+  BUGCOMM_OP_DRIVE,
+  BUGCOMM_OP_RUN_SCRIPT,
+  BUGCOMM_OP_STOP_SCRIPT
+};
+
+
+// Carrying the script in every packet keeps the command a fixed size, as NowComm requires.
+// It is about 130 bytes, well under the 250 byte ESP-Now limit.
+//
 typedef struct BugCommand {
   ulong         signature = NOWCOMM_SIGNATURE;
   uint16_t      version   = NOWCOMM_VERSION;
   NowComm_Kind  kind      = NOWCOMM_KIND_COMMAND;
+  BugComm_Op    op        = BUGCOMM_OP_DRIVE;
   int8_t        speed_0;
   int8_t        speed_1;
   int8_t        speed_2;
@@ -14,16 +34,22 @@ typedef struct BugCommand {
   uint32_t      color_left;
   uint32_t      color_right;
   bool          button;
+  BugScript     script;
 } BugCommand;
 
 
 class BugComm : public NowComm<BugCommand> {
   public:
     void        send_command(int8_t x, int8_t y, bool button);  // this takes x & y as +/- 128
+    void        run_script(const BugScript* script);            // Upload a script and start it on the receiver
+    void        stop_script();                                  // Stop the running script and bring the BugC to a halt
+    BugComm_Op  get_op();
+    BugScript*  get_script();
     uint32_t    get_light_color(uint8_t pos);
     uint8_t     get_motor_speed(uint8_t pos);
     uint8_t     get_button();
   private:
+    void        send_op(BugComm_Op op);
     int8_t      last_x  = 127;
     int8_t      last_y  = 127;
     bool        last_b  = false;
@@ -0,0 +1,124 @@
+#include <string.h>
+#include "BugScript.h"
+
+
+BugScriptRunner::BugScriptRunner(BugScript_Clock clock, BugScript_Output output, BugScript_Logger logger) {
+  this->clock   = clock;
+  this->output  = output;
+  this->logger  = logger;
+}
+
+
+// Copy and validate a script. If it is valid, it replaces the current one and a script that
+// is running is stopped; if not, the runner is left exactly as it was.
+// The source may be overwritten by the ESP-Now receive callback at any time, so it is copied
+// once and only the copy is validated and used.
+// Every segment must last at least BUGSCRIPT_MIN_DURATION, or a looping script could keep update() busy.
+//
+bool BugScriptRunner::load(const BugScript* new_script) {
+  BugScript candidate;
+  memcpy(&candidate, new_script, sizeof(BugScript));
+  if(0 == candidate.num_segments || BUGSCRIPT_MAX_SEGMENTS < candidate.num_segments) return false;
+  if(candidate.loop_start >= candidate.num_segments) return false;
+  for(uint8_t i = 0; i < candidate.num_segments; i++) {
+    BugScriptSegment* seg = &candidate.segments[i];
+    if(BUGSCRIPT_MIN_DURATION > seg->duration_ms) return false;
+    if(seg->ramp_ms > seg->duration_ms) seg->ramp_ms = seg->duration_ms;
+  }
+  memcpy(&script, &candidate, sizeof(BugScript));
+  running = false;
+  loaded  = true;
+  return true;
+}
+
+
+// Begin playback from the first segment. The speeds passed in are the ones the motors are
+// running at now, so the first segment ramps smoothly from them.
+//
+bool BugScriptRunner::start(int8_t speed_0, int8_t speed_1, int8_t speed_2, int8_t speed_3) {
+  if(!loaded) return false;
+  int8_t current[4] = {speed_0, speed_1, speed_2, speed_3};
+  memcpy(from_speeds,    current, 4);
+  memcpy(written_speeds, current, 4);
+  loops_remaining = script.loop_count;
+  max_error       = 0;
+  running         = true;
+  uint32_t now    = clock();
+  enter_segment(0, now, now);
+  if(logger) logger(0, 0, 0);
+  update();
+  return true;
+}
+
+
+// Advance through any segments whose time has passed, then set the motors to the speeds
+// called for at this instant. Segment start times are scheduled from the previous segment's
+// scheduled start, not from when update() noticed it, so lateness does not accumulate.
+// The logger is called at most once per update, for the segment entered last, with a count of
+// the segments passed over on the way, so logging can't make a late update later still.
+//
+void BugScriptRunner::update() {
+  if(!running) return;
+  uint32_t now      = clock();
+  uint16_t entered  = 0;
+  bool     finished = false;
+  while((now - segment_start) >= script.segments[segment].duration_ms) {
+    if(!advance(now)) {
+      finished = true;
+      break;
+    }
+    if(0xFFFF > entered) entered++;
+  }
+  if(entered && logger) logger(segment, last_error, entered - 1);
+  if(finished) return;
+  const BugScriptSegment* seg     = &script.segments[segment];
+  uint32_t                elapsed = now - segment_start;
+  int8_t                  out[4];
+  for(uint8_t i = 0; i < 4; i++) {
+    if(elapsed >= seg->ramp_ms) out[i] = seg->speeds[i];
+    else out[i] = from_speeds[i] + ((int32_t)(seg->speeds[i] - from_speeds[i]) * (int32_t)elapsed) / seg->ramp_ms;
+  }
+  write_speeds(out);
+}
+
+
+// Move to the segment following the current one, looping if required.
+// Return false if the script has finished, in which case the motors are stopped.
+//
+bool BugScriptRunner::advance(uint32_t now) {
+  const BugScriptSegment* seg       = &script.segments[segment];
+  uint32_t                scheduled = segment_start + seg->duration_ms;
+  uint8_t                 next      = segment + 1;
+  memcpy(from_speeds, seg->speeds, 4);  // ramp_ms <= duration_ms, so the target was reached
+  if(next >= script.num_segments) {
+    if(0 == loops_remaining) {
+      int8_t halt[4] = { 0 };
+      running = false;
+      write_speeds(halt);
+      return false;
+    }
+    if(BUGSCRIPT_LOOP_FOREVER != loops_remaining) loops_remaining--;
+    next = script.loop_start;
+  }
+  enter_segment(next, scheduled, now);
+  return true;
+}
+
+
+// Record the difference between when a segment was scheduled to start and when it actually started.
+//
+void BugScriptRunner::enter_segment(uint8_t index, uint32_t scheduled, uint32_t now) {
+  segment       = index;
+  segment_start = scheduled;
+  last_error    = (int32_t)(now - scheduled);
+  if(last_error > max_error) max_error = last_error;
+}
+
+
+// Only send speeds when they change, to avoid flooding the I2C bus from loop().
+//
+void BugScriptRunner::write_speeds(const int8_t* out) {
+  if(0 == memcmp(out, written_speeds, 4)) return;
+  memcpy(written_speeds, out, 4);
+  output(out[0], out[1], out[2], out[3]);
+}
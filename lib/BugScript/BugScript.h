@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+// Timed motion scripts for the BugC.
+// A script is uploaded once by the controller and played back locally by the receiver,
+// so choreographed moves are not at the mercy of radio jitter.
+//
+// A script is a list of segments. Each segment runs for duration_ms, ramping linearly
+// from the speeds in effect when it starts to its target speeds over the first ramp_ms,
+// then holding the target speeds for the remainder of the segment.
+// After the last segment, playback jumps back to loop_start loop_count more times
+// (BUGSCRIPT_LOOP_FOREVER repeats until stopped). When the script finishes, the motors stop.
+//
+// BugScriptRunner has no Arduino dependencies; the clock, motor output and logger are
+// supplied as function pointers so it can be exercised on the host against a mock clock.
+
+
+#define BUGSCRIPT_MAX_SEGMENTS  12
+#define BUGSCRIPT_LOOP_FOREVER  0xFF
+#define BUGSCRIPT_MIN_DURATION  20        // Shortest segment, in ms, so loop() is never starved catching up
+
+
+typedef struct BugScriptSegment {
+  uint16_t      duration_ms;      // Total length of the segment; at least BUGSCRIPT_MIN_DURATION
+  uint16_t      ramp_ms;          // Time to reach the target speeds; clamped to duration_ms
+  int8_t        speeds[4];        // Target speed of each motor, -100 to 100
+} BugScriptSegment;
+
+
+typedef struct BugScript {
+  uint8_t           num_segments;
+  uint8_t           loop_start;   // Segment to jump back to after the last one
+  uint8_t           loop_count;   // Additional passes from loop_start; 0 = play once
+  uint8_t           reserved;
+  BugScriptSegment  segments[BUGSCRIPT_MAX_SEGMENTS];
+} BugScript;
+
+
+typedef uint32_t  (*BugScript_Clock)();
+typedef void      (*BugScript_Output)(int8_t speed_0, int8_t speed_1, int8_t speed_2, int8_t speed_3);
+typedef void      (*BugScript_Logger)(uint8_t segment, int32_t start_error_ms, uint16_t skipped);
+
+
+class BugScriptRunner {
+  public:
+    BugScriptRunner(BugScript_Clock clock, BugScript_Output output, BugScript_Logger logger = nullptr);
+    bool          load(const BugScript* new_script);                      // Returns false, changing nothing, if the script is malformed
+    bool          start(int8_t speed_0, int8_t speed_1, int8_t speed_2, int8_t speed_3);  // Current motor speeds, for the first ramp
+    void          stop()                    { running = false;        }   // Without touching the motors; the caller sets them
+    void          update();                                               // Call as often as possible from loop()
+    bool          is_loaded()               { return loaded;          }
+    bool          is_running()              { return running;         }
+    uint8_t       get_segment()             { return segment;         }
+    int32_t       get_last_start_error()    { return last_error;      }
+    int32_t       get_max_start_error()     { return max_error;       }
+  private:
+    void          enter_segment(uint8_t index, uint32_t scheduled, uint32_t now);
+    bool          advance(uint32_t now);
+    void          write_speeds(const int8_t* out);
+    BugScript_Clock   clock;
+    BugScript_Output  output;
+    BugScript_Logger  logger;
+    BugScript     script;
+    bool          loaded              = false;
+    bool          running             = false;
+    uint8_t       segment             = 0;
+    uint8_t       loops_remaining     = 0;
+    uint32_t      segment_start       = 0;      // Scheduled, not actual, start time of the current segment
+    int32_t       last_error          = 0;
+    int32_t       max_error           = 0;
+    int8_t        from_speeds[4]      = { 0 };  // Speeds in effect when the current segment began
+    int8_t        written_speeds[4]   = { 0 };  // Last speeds sent to output
+};
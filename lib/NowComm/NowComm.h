@@ -4,7 +4,7 @@
 #include <WiFi.h>
 
 #define NOWCOMM_SIGNATURE       0x43574F4E
-#define NOWCOMM_VERSION         0X0211
+#define NOWCOMM_VERSION         0X0212
 #define BROADCAST_MAC_ADDRESS   {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}
 #define NOWCOMM_AP_NAME         "NowCommAP"
 
@@ -71,6 +71,7 @@ class NowComm {
     uint8_t*             get_peer_address()  { return peerAddress; }
     uint8_t              get_channel()       { return channel;     }
     NowComm_Kind         get_msg_kind()      { return msg_kind;    }
+    NowComm_Status       get_response_status() { return response.status; }
     T*                   get_data()          { return &command;    }
   protected:
     T                    command;
@@ -219,8 +220,8 @@ template <typename T> bool NowComm<T>::process_discovery_response() {
     else {
       Serial.print("COMM FAILURE: Incoming packet rejected. ");
       if(sizeof(NowComm_Discovery) != response_len) Serial.printf("Expected size: %d. Actual size: %d\n", sizeof(NowComm_Discovery), response_len);
-      else if(NOWCOMM_SIGNATURE != response.signature) Serial.printf("Expected signature: %d. Actual signature: %d\n", NOWCOMM_SIGNATURE, response.signature);
-      else if(NOWCOMM_VERSION   != response.version)   Serial.printf("Expected version: %d. Actual version: %d\n", NOWCOMM_VERSION, response.version);
+      else if(NOWCOMM_SIGNATURE != discovery.signature) Serial.printf("Expected signature: %d. Actual signature: %d\n", NOWCOMM_SIGNATURE, discovery.signature);
+      else if(NOWCOMM_VERSION   != discovery.version)   Serial.printf("Expected version: %04X. Actual version: %04X. Update the firmware on both devices.\n", NOWCOMM_VERSION, discovery.version);
       else if(discovery.mode    != (device_mode == NOWCOMM_MODE_CONTROLLER) ? NOWCOMM_MODE_RECEIVER : NOWCOMM_MODE_CONTROLLER) Serial.printf("Expected kind: %s. Actual kind: %s\n",
                                    (device_mode == NOWCOMM_MODE_CONTROLLER) ? "NOWCOMM_MODE_RECEIVER" : "NOWCOMM_MODE_CONTROLLER",
                                    (device_mode == NOWCOMM_MODE_CONTROLLER) ? "NOWCOMM_MODE_CONTROLLER" : "NOWCOMM_MODE_RECEIVER");
@@ -247,6 +248,7 @@ template <typename T> void NowComm<T>::on_data_sent(const uint8_t *mac_addr, esp
 //    |signature |ver        |kind       |data
 //
 template <typename T> void NowComm<T>::on_data_received(const uint8_t * mac, const uint8_t *incomingData, int len) {
+  bool version_mismatch = false;
 #ifdef DEBUG_DUMP_PACKET
   for(int i = 0; i < 6; i++) { Serial.printf("%02X", mac[i]); } Serial.print(" REC ");
   for(int i = 0; i < len; i++) { Serial.printf("%02X ", incomingData[i]); } Serial.println();
@@ -274,13 +276,14 @@ template <typename T> void NowComm<T>::on_data_received(const uint8_t * mac, con
     if(data_valid) data_valid = NOWCOMM_SIGNATURE == discovery.signature &&
                                 NOWCOMM_VERSION   == discovery.version;
     Serial.printf("Incoming discovery message received: %s\n", data_valid ? "Valid" : "Invalid");
+    version_mismatch = NOWCOMM_SIGNATURE == discovery.signature && !data_valid;  // Let process_discovery_response() report it
   }
   else {
     Serial.printf("Incoming message of unknown kind received: %d\n", ((uint32_t*)incomingData)[2]);
   }
   memcpy(&responseAddress, mac, 6);
   response_len  = len;
-  data_ready    = data_valid;
+  data_ready    = data_valid || version_mismatch;
 }
 
 
@@ -21,13 +21,59 @@
 #include "M5StickC.h"
 #include "BugCControl.h"
 #include "BugComm.h"
+#include "BugScript.h"
 
 #define BG_COLOR    NAVY
 #define FG_COLOR    LIGHTGREY
+#define SCRIPT_DISPLAY_MS     100   // Redraw script speeds at most 10 times a second
 
 BugCControl         bug;
 BugComm             bug_comm;
 bool                comp_mode             = false;    // Competition mode: manually select a channel
+bool                script_display_dirty  = false;    // The script runner changed speeds since the last redraw
+uint32_t            script_display_time   = 0;        // When script speeds were last redrawn
+
+
+// Clock for the script runner.
+//
+uint32_t script_clock() {
+  return millis();
+}
+
+
+// Report how late each script segment started, to monitor timing accuracy.
+// Skipped segments were passed over entirely because loop() fell that far behind.
+//
+void log_script_segment(uint8_t segment, int32_t start_error_ms, uint16_t skipped) {
+  if(skipped) Serial.printf("Script segment %d started %d ms late, %d skipped\n", segment, (int)start_error_ms, skipped);
+  else Serial.printf("Script segment %d started %d ms late\n", segment, (int)start_error_ms);
+}
+
+
+// Set the motor speeds from the script runner. The runner calls this on every change, up to once
+// a millisecond during a ramp, so the display is only marked for display_script_speeds().
+//
+void set_script_speeds(int8_t speed_0, int8_t speed_1, int8_t speed_2, int8_t speed_3) {
+  bug.set_all_speeds(speed_0, speed_1, speed_2, speed_3);
+  script_display_dirty = true;
+}
+
+
+// Redraw the speeds set by the script runner, no more often than SCRIPT_DISPLAY_MS.
+// Drawing takes several milliseconds, and doing it on every change would disturb the script's timing.
+//
+void display_script_speeds() {
+  if(!script_display_dirty || SCRIPT_DISPLAY_MS > millis() - script_display_time) return;
+  script_display_dirty  = false;
+  script_display_time   = millis();
+  bug.display_speed(0, bug.get_speed(0));
+  bug.display_speed(1, bug.get_speed(1));
+  bug.display_speed(2, bug.get_speed(2));
+  bug.display_speed(3, bug.get_speed(3));
+}
+
+
+BugScriptRunner     bug_script(script_clock, set_script_speeds, log_script_segment);
 
 
 // Display the mac address of the device, and if connected, of its paired device.
@@ -83,13 +129,35 @@ uint8_t select_comm_channel() {
 }
 
 
-// See if valid data has been received, and if so set all data outputs (2 NeoPixels and 4 speeds)
-// Send a response indicating whether or not the data received was valid.
+// See if valid data has been received, and if so act on it according to its op:
+// Drive commands set all data outputs (2 NeoPixels and 4 speeds) and preempt any running script.
+// Script commands start or stop a motion script that is played back locally.
+// A rejected script is reported to the controller with an error response.
 //
 void handle_incoming_data() {
   if(bug_comm.is_data_ready()) {
 //Serial.printf("%3d %3d %3d %3d\n", bug_comm.get_motor_speed(0), bug_comm.get_motor_speed(1), bug_comm.get_motor_speed(2), bug_comm.get_motor_speed(3));
     bug_comm.clear_data_ready();
+    if(NOWCOMM_KIND_COMMAND != bug_comm.get_msg_kind()) return;   // e.g. a stray discovery packet; don't replay the last command
+    switch(bug_comm.get_op()) {
+      case BUGCOMM_OP_RUN_SCRIPT:
+        if(!bug_script.load(bug_comm.get_script())) {
+          Serial.println("Rejected malformed script");
+          bug_comm.send_response(NOWCOMM_RESP_ERROR);
+          bug_script.stop();  // Don't leave the motors running a script the controller has replaced
+          bug.come_to_halt();
+          return;
+        }
+        bug_script.start(bug.get_speed(0), bug.get_speed(1), bug.get_speed(2), bug.get_speed(3));
+        return;
+      case BUGCOMM_OP_STOP_SCRIPT:
+        bug_script.stop();
+        bug.come_to_halt();
+        return;
+      default:
+        bug_script.stop();    // Live commands take precedence over a running script, and set the motors below
+        break;
+    }
     bug.set_lights(bug_comm.get_light_color(0), bug_comm.get_light_color(1));  // set the NeoPixels on the front of the BugC
     bug.set_all_speeds(bug_comm.get_motor_speed(0), bug_comm.get_motor_speed(1), bug_comm.get_motor_speed(2), bug_comm.get_motor_speed(3));
     digitalWrite(M5_LED, !bug_comm.get_button());         // Turn on the LED if button is True
@@ -145,6 +213,11 @@ void setup() {
 //
 void loop() {
   M5.update();                                // So M5.BtnA.isPressed() works
-  if(M5.BtnA.isPressed()) bug.come_to_halt(); // In case the transmitter dies, pressing the button turns everything off.
+  if(M5.BtnA.isPressed()) {                   // In case the transmitter dies, pressing the button turns everything off.
+    bug_script.stop();
+    bug.come_to_halt();
+  }
   handle_incoming_data();                     // Handle ESP-Now communications
+  bug_script.update();                        // Play back any running motion script
+  display_script_speeds();                    // ...and show its speeds, throttled
 }
@@ -0,0 +1,309 @@
+// Host tests for BugScriptRunner, driven by a fake clock.
+// Run with: pio test -e native
+
+#include <unity.h>
+#include <string.h>
+#include "BugScript.h"
+
+
+static uint32_t fake_now      = 0;
+static int8_t   motor[4]      = { 0 };
+static int      output_count  = 0;
+static int      log_count     = 0;
+static uint8_t  log_segment   = 0;
+static int32_t  log_error     = 0;
+static uint16_t log_skipped   = 0;
+
+
+uint32_t fake_clock() {
+  return fake_now;
+}
+
+
+void fake_output(int8_t speed_0, int8_t speed_1, int8_t speed_2, int8_t speed_3) {
+  motor[0] = speed_0;
+  motor[1] = speed_1;
+  motor[2] = speed_2;
+  motor[3] = speed_3;
+  output_count++;
+}
+
+
+void fake_logger(uint8_t segment, int32_t start_error_ms, uint16_t skipped) {
+  log_segment = segment;
+  log_error   = start_error_ms;
+  log_skipped = skipped;
+  log_count++;
+}
+
+
+BugScriptSegment make_segment(uint16_t duration_ms, uint16_t ramp_ms, int8_t s0, int8_t s1, int8_t s2, int8_t s3) {
+  BugScriptSegment seg = { duration_ms, ramp_ms, { s0, s1, s2, s3 } };
+  return seg;
+}
+
+
+// Advance the fake clock and let the runner catch up.
+//
+void run_to(BugScriptRunner& runner, uint32_t now) {
+  fake_now = now;
+  runner.update();
+}
+
+
+void assert_motors(int8_t s0, int8_t s1, int8_t s2, int8_t s3) {
+  TEST_ASSERT_EQUAL_INT8(s0, motor[0]);
+  TEST_ASSERT_EQUAL_INT8(s1, motor[1]);
+  TEST_ASSERT_EQUAL_INT8(s2, motor[2]);
+  TEST_ASSERT_EQUAL_INT8(s3, motor[3]);
+}
+
+
+void setUp() {
+  fake_now      = 1000;
+  output_count  = 0;
+  log_count     = 0;
+  log_segment   = 0;
+  log_error     = 0;
+  log_skipped   = 0;
+  memset(motor, 0, sizeof(motor));
+}
+
+
+void tearDown() {}
+
+
+void test_ramp_interpolation() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 2;
+  script.segments[0]      = make_segment(100, 100, 100, -100, 50, 0);
+  script.segments[1]      = make_segment(100,  50,   0,    0,  0, 0);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  run_to(runner, 1025);
+  assert_motors(25, -25, 12, 0);
+  run_to(runner, 1050);
+  assert_motors(50, -50, 25, 0);
+  run_to(runner, 1099);
+  assert_motors(99, -99, 49, 0);
+  run_to(runner, 1125);                     // Second segment ramps down from the first's target
+  assert_motors(50, -50, 25, 0);
+  run_to(runner, 1150);
+  assert_motors(0, 0, 0, 0);
+  TEST_ASSERT_TRUE(runner.is_running());
+}
+
+
+void test_ramp_starts_from_current_speeds() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 1;
+  script.segments[0]      = make_segment(200, 100, 100, 100, 100, 100);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(20, -20, 0, 100));
+  run_to(runner, 1050);
+  assert_motors(60, 40, 50, 100);
+}
+
+
+void test_ramp_longer_than_duration_is_clamped() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 2;
+  script.segments[0]      = make_segment(100, 500, 100, 100, 100, 100);
+  script.segments[1]      = make_segment(100,   0, 100, 100, 100, 100);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  run_to(runner, 1050);
+  assert_motors(50, 50, 50, 50);            // Unclamped, this would be 10
+  run_to(runner, 1100);
+  assert_motors(100, 100, 100, 100);
+}
+
+
+void test_finite_loop() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 2;
+  script.loop_start       = 1;
+  script.loop_count       = 2;
+  script.segments[0]      = make_segment(20, 0, 10, 10, 10, 10);
+  script.segments[1]      = make_segment(20, 0, 20, 20, 20, 20);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  assert_motors(10, 10, 10, 10);
+  uint8_t expected[] = { 1, 1, 1 };         // Segment 1 once, then two more passes
+  for(uint8_t i = 0; i < sizeof(expected); i++) {
+    run_to(runner, 1020 + 20 * i);
+    TEST_ASSERT_TRUE(runner.is_running());
+    TEST_ASSERT_EQUAL_UINT8(expected[i], runner.get_segment());
+    assert_motors(20, 20, 20, 20);
+  }
+  TEST_ASSERT_EQUAL_INT(4, log_count);
+  run_to(runner, 1079);
+  TEST_ASSERT_TRUE(runner.is_running());
+  run_to(runner, 1080);
+  TEST_ASSERT_FALSE(runner.is_running());
+  assert_motors(0, 0, 0, 0);
+}
+
+
+void test_loop_forever() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 2;
+  script.loop_count       = BUGSCRIPT_LOOP_FOREVER;
+  script.segments[0]      = make_segment(20, 0,  50,  50,  50,  50);
+  script.segments[1]      = make_segment(20, 0, -50, -50, -50, -50);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  for(uint32_t t = 1000; t < 1000 + 300 * 40; t += 20) {
+    run_to(runner, t);
+    TEST_ASSERT_TRUE(runner.is_running());
+    TEST_ASSERT_EQUAL_UINT8(((t - 1000) / 20) % 2, runner.get_segment());
+  }
+  runner.stop();
+  TEST_ASSERT_FALSE(runner.is_running());
+}
+
+
+void test_late_update_does_not_accumulate_error() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 4;
+  script.segments[0]      = make_segment(100, 0, 10, 10, 10, 10);
+  script.segments[1]      = make_segment(100, 0, 20, 20, 20, 20);
+  script.segments[2]      = make_segment(100, 0, 30, 30, 30, 30);
+  script.segments[3]      = make_segment(100, 0, 40, 40, 40, 40);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  TEST_ASSERT_EQUAL_INT32(0, log_error);
+  run_to(runner, 1130);                     // 30 ms late for segment 1
+  TEST_ASSERT_EQUAL_UINT8(1, log_segment);
+  TEST_ASSERT_EQUAL_INT32(30, log_error);
+  run_to(runner, 1200);                     // Segment 2 is still scheduled at 1200, not 1230
+  TEST_ASSERT_EQUAL_UINT8(2, log_segment);
+  TEST_ASSERT_EQUAL_INT32(0, log_error);
+  TEST_ASSERT_EQUAL_INT32(30, runner.get_max_start_error());
+  run_to(runner, 1400);                     // Segment 3 was missed entirely; the script ends on time
+  TEST_ASSERT_FALSE(runner.is_running());
+  TEST_ASSERT_EQUAL_UINT8(3, log_segment);
+  TEST_ASSERT_EQUAL_INT32(100, log_error);
+}
+
+
+void test_catch_up_logs_once() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 2;
+  script.loop_count       = BUGSCRIPT_LOOP_FOREVER;
+  script.segments[0]      = make_segment(BUGSCRIPT_MIN_DURATION, 0,  50,  50,  50,  50);
+  script.segments[1]      = make_segment(BUGSCRIPT_MIN_DURATION, 0, -50, -50, -50, -50);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  TEST_ASSERT_EQUAL_INT(1, log_count);
+  run_to(runner, 1000 + 10 * BUGSCRIPT_MIN_DURATION + 5);   // Ten segment boundaries passed in one update
+  TEST_ASSERT_EQUAL_INT(2, log_count);
+  TEST_ASSERT_EQUAL_UINT8(0, log_segment);
+  TEST_ASSERT_EQUAL_INT32(5, log_error);
+  TEST_ASSERT_EQUAL_UINT16(9, log_skipped);
+  assert_motors(50, 50, 50, 50);
+}
+
+
+void test_load_rejects_bad_scripts() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  TEST_ASSERT_FALSE(runner.load(&script));  // No segments
+
+  script.num_segments     = BUGSCRIPT_MAX_SEGMENTS + 1;
+  for(uint8_t i = 0; i < BUGSCRIPT_MAX_SEGMENTS; i++) script.segments[i] = make_segment(BUGSCRIPT_MIN_DURATION, 0, 0, 0, 0, 0);
+  TEST_ASSERT_FALSE(runner.load(&script));  // Too many segments
+
+  script.num_segments     = 2;
+  script.loop_start       = 2;
+  TEST_ASSERT_FALSE(runner.load(&script));  // Loop start past the end
+
+  script.loop_start       = 1;
+  script.segments[1]      = make_segment(0, 0, 0, 0, 0, 0);
+  TEST_ASSERT_FALSE(runner.load(&script));  // Zero duration
+
+  script.segments[1]      = make_segment(BUGSCRIPT_MIN_DURATION - 1, 0, 0, 0, 0, 0);
+  TEST_ASSERT_FALSE(runner.load(&script));  // Too short to keep loop() responsive
+  TEST_ASSERT_FALSE(runner.is_loaded());
+  TEST_ASSERT_FALSE(runner.start(0, 0, 0, 0));
+
+  script.segments[1]      = make_segment(BUGSCRIPT_MIN_DURATION, 0, 0, 0, 0, 0);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.is_loaded());
+}
+
+
+void test_failed_load_leaves_running_script() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 1;
+  script.segments[0]      = make_segment(100, 0, 40, 40, 40, 40);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  BugScript       bad     = {};
+  TEST_ASSERT_FALSE(runner.load(&bad));
+  TEST_ASSERT_TRUE(runner.is_loaded());
+  TEST_ASSERT_TRUE(runner.is_running());
+  run_to(runner, 1050);
+  assert_motors(40, 40, 40, 40);
+}
+
+
+void test_stop_leaves_motors_untouched() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 1;
+  script.segments[0]      = make_segment(100, 100, 100, 100, 100, 100);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  run_to(runner, 1050);
+  int writes = output_count;
+  runner.stop();
+  TEST_ASSERT_FALSE(runner.is_running());
+  run_to(runner, 1500);
+  TEST_ASSERT_EQUAL_INT(writes, output_count);
+  assert_motors(50, 50, 50, 50);
+}
+
+
+void test_halts_at_end() {
+  BugScriptRunner runner(fake_clock, fake_output, fake_logger);
+  BugScript       script  = {};
+  script.num_segments     = 1;
+  script.segments[0]      = make_segment(100, 0, 60, -60, 60, -60);
+  TEST_ASSERT_TRUE(runner.load(&script));
+  TEST_ASSERT_TRUE(runner.start(0, 0, 0, 0));
+  assert_motors(60, -60, 60, -60);
+  run_to(runner, 1099);
+  TEST_ASSERT_TRUE(runner.is_running());
+  run_to(runner, 1100);
+  TEST_ASSERT_FALSE(runner.is_running());
+  assert_motors(0, 0, 0, 0);
+  int writes = output_count;
+  run_to(runner, 2000);
+  TEST_ASSERT_EQUAL_INT(writes, output_count);
+}
+
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ramp_interpolation);
+  RUN_TEST(test_ramp_starts_from_current_speeds);
+  RUN_TEST(test_ramp_longer_than_duration_is_clamped);
+  RUN_TEST(test_finite_loop);
+  RUN_TEST(test_loop_forever);
+  RUN_TEST(test_late_update_does_not_accumulate_error);
+  RUN_TEST(test_catch_up_logs_once);
+  RUN_TEST(test_load_rejects_bad_scripts);
+  RUN_TEST(test_failed_load_leaves_running_script);
+  RUN_TEST(test_stop_leaves_motors_untouched);
+  RUN_TEST(test_halts_at_end);
+  return UNITY_END();
+}